@@ -0,0 +1,210 @@
+#include "trap_common/ciphertext_corpus.h"
+#include "trap_common/trap_common.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace seal;
+
+// Trap scanner for ciphertext corpora. Streams the memory-mapped corpus window by window:
+// upcoming windows are prefetched with MADV_WILLNEED, finished ones dropped with
+// MADV_DONTNEED, so corpora larger than RAM scan with a bounded resident set.
+
+struct ScanOptions {
+    string corpus = "trap_corpus.bin";
+    string key_dir = "trap_keys";
+    size_t workers = 0;          // 0 = hardware concurrency
+    uint64_t window_bytes = 64u << 20;
+    size_t readahead = 4;        // windows prefetched ahead of the scan
+    int threshold = -1;          // -1 = 33% of the fresh-ciphertext budget
+};
+
+struct FlaggedEntry {
+    uint64_t index;
+    uint64_t expected;
+    TrapVerdict verdict;
+};
+
+struct ScanTotals {
+    uint64_t entries = 0;
+    uint64_t bytes = 0;
+    uint64_t status_counts[4] = {};
+    uint64_t zone_counts[3] = {};
+    vector<FlaggedEntry> flagged; // first few non-OK entries, for the report
+};
+
+constexpr size_t MAX_REPORTED = 10;
+
+// Splits the corpus into [first, last) entry ranges of roughly window_bytes each
+vector<pair<uint64_t, uint64_t>> make_windows(const CorpusReader &reader, uint64_t window_bytes) {
+    vector<pair<uint64_t, uint64_t>> windows;
+    uint64_t first = 0, bytes = 0;
+    for (uint64_t i = 0; i < reader.count(); i++) {
+        bytes += reader.entry_bytes(i);
+        if (bytes >= window_bytes) {
+            windows.emplace_back(first, i + 1);
+            first = i + 1;
+            bytes = 0;
+        }
+    }
+    if (first < reader.count()) {
+        windows.emplace_back(first, reader.count());
+    }
+    return windows;
+}
+
+void scan_worker(const SEALContext &context, const SecretKey &secret_key, const CorpusReader &reader,
+                 const vector<pair<uint64_t, uint64_t>> &windows, size_t readahead, int baseline_budget,
+                 int threshold, atomic<size_t> &next_window, ScanTotals &totals, mutex &totals_mutex) {
+    Decryptor decryptor(context, secret_key);
+    MemoryPoolHandle pool = MemoryPoolHandle::New();
+    Ciphertext encrypted(pool);
+    Plaintext decrypted(pool);
+    ScanTotals local;
+
+    for (size_t w = next_window++; w < windows.size(); w = next_window++) {
+        if (w + readahead < windows.size()) {
+            reader.advise_willneed(windows[w + readahead].first, windows[w + readahead].second);
+        }
+        for (uint64_t i = windows[w].first; i < windows[w].second; i++) {
+            const CorpusEntry &entry = reader.entry(i);
+            bool has_expected = (entry.flags & CORPUS_ENTRY_HAS_EXPECTED) != 0;
+            TrapVerdict verdict;
+            try {
+                reader.load(context, i, encrypted);
+                verdict = verify_ciphertext(decryptor, encrypted, decrypted, has_expected, entry.expected_value,
+                                            baseline_budget, threshold);
+            } catch (const exception &) {
+                verdict = TrapVerdict{}; // ERROR
+            }
+            local.entries++;
+            local.bytes += reader.entry_bytes(i);
+            local.status_counts[static_cast<size_t>(verdict.status)]++;
+            if (verdict.status != TrapStatus::ERROR) { // no budget was measured
+                local.zone_counts[static_cast<size_t>(verdict.zone)]++;
+            }
+            if (verdict.status != TrapStatus::OK && local.flagged.size() < MAX_REPORTED) {
+                local.flagged.push_back({i, entry.expected_value, verdict});
+            }
+        }
+        reader.advise_dontneed(windows[w].first, windows[w].second);
+    }
+
+    lock_guard<mutex> lock(totals_mutex);
+    totals.entries += local.entries;
+    totals.bytes += local.bytes;
+    for (int s = 0; s < 4; s++) totals.status_counts[s] += local.status_counts[s];
+    for (int z = 0; z < 3; z++) totals.zone_counts[z] += local.zone_counts[z];
+    totals.flagged.insert(totals.flagged.end(), local.flagged.begin(), local.flagged.end());
+}
+
+int main(int argc, char **argv) {
+    ScanOptions options;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--keys" && i + 1 < argc) options.key_dir = argv[++i];
+        else if (arg == "--workers" && i + 1 < argc) options.workers = stoul(argv[++i]);
+        else if (arg == "--window-mb" && i + 1 < argc) options.window_bytes = stoull(argv[++i]) << 20;
+        else if (arg == "--readahead" && i + 1 < argc) options.readahead = stoul(argv[++i]);
+        else if (arg == "--threshold" && i + 1 < argc) options.threshold = stoi(argv[++i]);
+        else if (arg[0] != '-') options.corpus = arg;
+        else {
+            cerr << "Usage: corpus_scan [CORPUS] [--keys DIR] [--workers N] [--window-mb N] [--readahead N]"
+                 << " [--threshold BITS]" << endl;
+            return 1;
+        }
+    }
+    if (options.workers == 0) options.workers = max(1u, thread::hardware_concurrency());
+    if (options.window_bytes == 0) options.window_bytes = 1;
+
+    // Trusted side: needs the secret key
+    EncryptionParameters parms = load_trap_parameters(options.key_dir);
+    SEALContext context(parms, true);
+    print_trap_parameters(context);
+    SecretKey secret_key = load_trap_secret_key(context, options.key_dir);
+    PublicKey public_key = load_trap_public_key(context, options.key_dir);
+
+    Encryptor encryptor(context, public_key);
+    Decryptor decryptor(context, secret_key);
+    Plaintext fresh_plain("1");
+    Ciphertext fresh;
+    encryptor.encrypt(fresh_plain, fresh);
+    int baseline_budget = decryptor.invariant_noise_budget(fresh);
+    int threshold = options.threshold >= 0 ? options.threshold : danger_threshold(baseline_budget);
+
+    CorpusReader reader(options.corpus);
+    auto context_data = context.get_context_data(reader.parms_id());
+    if (!context_data || context_data->parms().poly_modulus_degree() != reader.header().poly_modulus_degree ||
+        context_data->parms().coeff_modulus().size() != reader.header().coeff_modulus_size) {
+        cerr << "Error: " << options.corpus << " was written for different encryption parameters" << endl;
+        return 1;
+    }
+
+    auto windows = make_windows(reader, options.window_bytes);
+    for (size_t w = 0; w < min(options.readahead, windows.size()); w++) {
+        reader.advise_willneed(windows[w].first, windows[w].second);
+    }
+
+    cout << "\nScanning " << options.corpus << endl;
+    cout << string(100, '-') << endl;
+    cout << "- Entries: " << reader.count() << " (" << fixed << setprecision(2) << reader.file_size() / 1e9 << " GB)" << endl;
+    cout << "- Windows: " << windows.size() << " × " << (options.window_bytes >> 20) << " MiB, readahead "
+         << options.readahead << endl;
+    cout << "- Workers: " << options.workers << endl;
+    cout << "- Baseline noise budget: " << baseline_budget << " bits, danger threshold: " << threshold << " bits" << endl;
+
+    ScanTotals totals;
+    mutex totals_mutex;
+    atomic<size_t> next_window{0};
+    vector<thread> workers;
+    auto start = chrono::steady_clock::now();
+    for (size_t t = 0; t < options.workers; t++) {
+        workers.emplace_back(scan_worker, cref(context), cref(secret_key), cref(reader), cref(windows), options.readahead,
+                             baseline_budget, threshold, ref(next_window), ref(totals), ref(totals_mutex));
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    sort(totals.flagged.begin(), totals.flagged.end(),
+         [](const FlaggedEntry &a, const FlaggedEntry &b) { return a.index < b.index; });
+    if (!totals.flagged.empty()) {
+        cout << "\nFlagged entries (first " << min(totals.flagged.size(), MAX_REPORTED) << "):" << endl;
+        cout << string(100, '-') << endl;
+        cout << setw(15) << "Entry"
+             << setw(15) << "Value"
+             << setw(15) << "Expected"
+             << setw(20) << "Noise Budget"
+             << setw(15) << "Zone"
+             << setw(15) << "Status" << endl;
+        cout << string(100, '-') << endl;
+        for (size_t f = 0; f < min(totals.flagged.size(), MAX_REPORTED); f++) {
+            const FlaggedEntry &flagged = totals.flagged[f];
+            cout << setw(15) << flagged.index
+                 << setw(15) << flagged.verdict.value
+                 << setw(15) << flagged.expected
+                 << setw(20) << (flagged.verdict.noise_budget > 0 ? to_string(flagged.verdict.noise_budget) + " bits" : "0 bits")
+                 << setw(15) << (flagged.verdict.status == TrapStatus::ERROR ? "-" : zone_name(flagged.verdict.zone))
+                 << setw(15) << status_name(flagged.verdict.status) << endl;
+        }
+    }
+
+    cout << "\nScan Summary:" << endl;
+    cout << "1. Scanned " << totals.entries << " ciphertexts (" << setprecision(2) << totals.bytes / 1e9 << " GB) in "
+         << elapsed << " s" << endl;
+    cout << "2. Throughput: " << totals.bytes / 1e9 / elapsed << " GB/s, " << setprecision(1)
+         << totals.entries / elapsed << " ciphertexts/s" << endl;
+    cout << "3. Status counts: OK=" << totals.status_counts[0] << " DANGER=" << totals.status_counts[1]
+         << " CORRUPTED=" << totals.status_counts[2] << " ERROR=" << totals.status_counts[3] << endl;
+    cout << "4. Zone counts: SAFE=" << totals.zone_counts[0] << " WARNING=" << totals.zone_counts[1]
+         << " DANGER=" << totals.zone_counts[2] << " (ERROR entries have no zone)" << endl;
+
+    return 0;
+}
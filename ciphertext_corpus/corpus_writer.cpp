@@ -0,0 +1,73 @@
+#include "trap_common/ciphertext_corpus.h"
+#include "trap_common/trap_common.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace seal;
+
+// Writes a ciphertext corpus for corpus_scan. Uses the untrusted side of the key directory
+// (parms.bin, public_key.bin) and the overflow_trap_demo workload: legitimate 100 × 10
+// results plus every Nth entry a multiply-by-1 attacked copy.
+
+int main(int argc, char **argv) {
+    string output = "trap_corpus.bin";
+    string key_dir = "trap_keys";
+    uint64_t count = 256;
+    uint64_t attack_every = 8;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--keys" && i + 1 < argc) key_dir = argv[++i];
+        else if (arg == "--count" && i + 1 < argc) count = stoull(argv[++i]);
+        else if (arg == "--attack-every" && i + 1 < argc) attack_every = stoull(argv[++i]);
+        else if (arg[0] != '-') output = arg;
+        else {
+            cerr << "Usage: corpus_writer [OUTPUT] [--keys DIR] [--count N] [--attack-every N]" << endl;
+            return 1;
+        }
+    }
+
+    EncryptionParameters parms = load_trap_parameters(key_dir);
+    SEALContext context(parms, true);
+    print_trap_parameters(context);
+    PublicKey public_key = load_trap_public_key(context, key_dir);
+    Encryptor encryptor(context, public_key);
+    Evaluator evaluator(context);
+
+    // A handful of distinct ciphertexts, cycled to build large corpora quickly
+    const size_t variants = 4;
+    vector<Ciphertext> legitimate(variants), attacked(variants);
+    Plaintext plain1("64"), plain2("A"), one_plain("1"); // hex: 100, 10, 1
+    for (size_t v = 0; v < variants; v++) {
+        Ciphertext encrypted1, encrypted2, encrypted_one;
+        encryptor.encrypt(plain1, encrypted1);
+        encryptor.encrypt(plain2, encrypted2);
+        encryptor.encrypt(one_plain, encrypted_one);
+        evaluator.multiply(encrypted1, encrypted2, legitimate[v]);
+        attacked[v] = legitimate[v];
+        for (int i = 0; i < 3; i++) {
+            evaluator.multiply_inplace(attacked[v], encrypted_one);
+        }
+    }
+
+    auto start = chrono::steady_clock::now();
+    CorpusWriter writer(output, context, legitimate[0].parms_id(), count);
+    uint64_t attack_count = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        bool attack = attack_every > 0 && i % attack_every == attack_every - 1;
+        writer.append(attack ? attacked[i % variants] : legitimate[i % variants], true, 1000);
+        attack_count += attack ? 1 : 0;
+    }
+    writer.finish();
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << "\nCorpus written: " << output << endl;
+    cout << string(100, '-') << endl;
+    cout << "- Entries: " << count << " (" << attack_count << " attacked)" << endl;
+    cout << "- Size: " << fixed << setprecision(2) << writer.bytes_written() / 1e9 << " GB" << endl;
+    cout << "- Write rate: " << writer.bytes_written() / 1e9 / elapsed << " GB/s" << endl;
+
+    return 0;
+}
@@ -1,4 +1,5 @@
 #include "seal/seal.h"
+#include "trap_common/plaintext_range.h"
 #include <iostream>
 #include <vector>
 #include <iomanip>  
@@ -29,26 +30,31 @@ int main() {
     keygen.create_public_key(public_key);
     SecretKey secret_key = keygen.secret_key();
     Encryptor encryptor(context, public_key);
-    Evaluator evaluator(context);
+    RangeCheckedEvaluator evaluator(context, PlainEncoding::COEFFICIENT);
     Decryptor decryptor(context, secret_key);
 
     Plaintext plain("2");
-    Ciphertext encrypted;
-    encryptor.encrypt(plain, encrypted);
+    Ciphertext fresh;
+    encryptor.encrypt(plain, fresh);
 
     cout << "\nStarting homomorphic multiplications:" << endl;
-    cout << string(100, '-') << endl;
+    cout << string(115, '-') << endl;
     cout << setw(15) << "Operation" 
          << setw(15) << "Value" 
          << setw(20) << "Expected"
          << setw(20) << "Noise Budget"
          << setw(20) << "Overflow Zone"
+         << setw(15) << "Range Check"
          << setw(15) << "Status" << endl;
-    cout << string(100, '-') << endl;
+    cout << string(115, '-') << endl;
 
-    uint64_t expected_value = 2;
+    // Expected value is shadowed in saturating 128-bit arithmetic (2^128 no longer wraps uint64),
+    // and the range-checked evaluator predicts the wrap mod p before each multiplication runs
+    wide_int expected_value = 2;
+    TrackedCiphertext encrypted = evaluator.track(fresh, vector<uint64_t>{2});
+    int wrap_predicted_at = -1;
     bool overflow_detected = false;
-    int initial_noise = decryptor.invariant_noise_budget(encrypted);
+    int initial_noise = decryptor.invariant_noise_budget(encrypted.encrypted);
     
     for (int i = 0; i <= 7; i++) {
         Plaintext temp_plain;
@@ -57,19 +63,19 @@ int main() {
         int noise_budget = 0;
 
         try {
-            noise_budget = decryptor.invariant_noise_budget(encrypted);
+            noise_budget = decryptor.invariant_noise_budget(encrypted.encrypted);
         } catch (...) {
             noise_budget = 0;
         }
 
         try {
             // Always attempt decryption, even after overflow
-            decryptor.decrypt(encrypted, temp_plain);
-            decrypted_value = temp_plain.to_string();
+            decryptor.decrypt(encrypted.encrypted, temp_plain);
             
-            // Check if the decrypted value matches expected value
-            uint64_t decrypted_num = stoull(decrypted_value);
-            if (decrypted_num != expected_value) {
+            // Show and compare coefficient 0 in decimal (to_string() would print hex)
+            uint64_t decrypted_num = temp_plain[0];
+            decrypted_value = to_string(decrypted_num);
+            if (static_cast<wide_int>(decrypted_num) != expected_value) {
                 status = "CORRUPTED";
                 overflow_detected = true;
             } else {
@@ -87,15 +93,20 @@ int main() {
         // Print status for this iteration
         cout << setw(15) << "2^" + to_string(1 << i)
              << setw(15) << decrypted_value
-             << setw(20) << expected_value
+             << setw(20) << wide_to_string(expected_value)
              << setw(20) << (noise_budget > 0 ? to_string(noise_budget) + " bits" : "0 bits")
              << setw(20) << zone
+             << setw(15) << (encrypted.range.wraps() ? "WRAPS mod p" : "IN RANGE")
              << setw(15) << status << endl;
 
         if (i < 7) { // Skip last multiplication
+            // The range is predicted before multiplying (no secret-key operation involved);
+            // RUN keeps squaring past the wrap so the corruption shows up in the table
             try {
-                evaluator.multiply_inplace(encrypted, encrypted);
-                expected_value = expected_value * expected_value;
+                if (!evaluator.multiply_inplace(encrypted, encrypted, WrapAction::RUN) && wrap_predicted_at < 0) {
+                    wrap_predicted_at = i + 1;
+                }
+                expected_value = saturating_mul(expected_value, expected_value);
             } catch (const exception &e) {
                 cout << "\nMultiplication failed at step " << i + 1 << endl;
                 cout << "Error: " << e.what() << endl;
@@ -111,6 +122,10 @@ int main() {
     cout << "4. After overflow, decryption produces corrupted values (if it works at all)" << endl;
     cout << "5. This matches the 'Attacked c' region in the diagram where values exceed p" << endl;
     cout << "6. The corrupted values demonstrate the 'mod p' operation in the diagram" << endl;
+    if (wrap_predicted_at > 0) {
+        cout << "7. The range tracker predicted the wrap mod p before multiplication " << wrap_predicted_at
+             << ", without decrypting" << endl;
+    }
 
     return 0;
 }
@@ -0,0 +1,492 @@
+#include "trap_protocol.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <future>
+#include <iomanip>
+#include <mutex>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace seal;
+
+// Long-running overflow trap: loads the context and keys once, accepts serialized
+// ciphertexts over a Unix domain socket (or a leased shared-memory slot), coalesces
+// concurrent requests into batches and answers each with status, noise bits and zone.
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void handle_stop_signal(int) {
+    stop_requested = 1;
+}
+
+struct DaemonOptions {
+    string socket_path = "/tmp/overflow_trap.sock";
+    string key_dir = "trap_keys";
+    size_t max_batch = 32;
+    size_t workers = 0; // 0 = hardware concurrency
+    int threshold = -1; // -1 = 33% of the fresh-ciphertext budget
+    bool use_shm = true;
+};
+
+struct PendingVerify {
+    TrapRequest request{};
+    vector<seal_byte> payload; // socket payloads only
+    const seal_byte *data = nullptr; // payload.data() or the leased shm slot
+    size_t size = 0;
+    promise<TrapResponse> done;
+};
+
+struct DaemonStats {
+    atomic<uint64_t> requests{0};
+    atomic<uint64_t> batches{0};
+    atomic<uint64_t> bytes{0};
+    atomic<uint64_t> status_counts[4]{};
+};
+
+// Coalesces requests from all connections. Verification gets no cheaper per item in a
+// batch, so an idle worker never waits for more requests: it takes its share of whatever
+// is queued (backlog split across the idle workers, at most max_batch). Batches larger
+// than one form only while every worker is busy and requests pile up.
+class BatchQueue {
+public:
+    explicit BatchQueue(size_t max_batch) : max_batch_(max_batch) {}
+
+    void push(PendingVerify *item) {
+        {
+            lock_guard<mutex> lock(mutex_);
+            queue_.push_back(item);
+        }
+        cv_.notify_all();
+    }
+
+    // Returns false once closed and drained
+    bool pop_batch(vector<PendingVerify *> &batch) {
+        batch.clear();
+        unique_lock<mutex> lock(mutex_);
+        idle_workers_++;
+        cv_.wait(lock, [this] { return closed_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            idle_workers_--;
+            return false;
+        }
+
+        size_t share = (queue_.size() + idle_workers_ - 1) / idle_workers_;
+        size_t take = min(share, max_batch_);
+        while (!queue_.empty() && batch.size() < take) {
+            batch.push_back(queue_.front());
+            queue_.pop_front();
+        }
+        idle_workers_--;
+        bool more = !queue_.empty();
+        lock.unlock();
+        if (more) {
+            cv_.notify_one();
+        }
+        return true;
+    }
+
+    void close() {
+        {
+            lock_guard<mutex> lock(mutex_);
+            closed_ = true;
+        }
+        cv_.notify_all();
+    }
+
+private:
+    size_t max_batch_;
+    size_t idle_workers_ = 0; // workers currently inside pop_batch()
+    mutex mutex_;
+    condition_variable cv_;
+    deque<PendingVerify *> queue_;
+    bool closed_ = false;
+};
+
+// Shared-memory ring of fixed-size slots, each leased to at most one connection
+class SlotLeases {
+public:
+    explicit SlotLeases(size_t count) : in_use_(count, false) {}
+
+    int acquire() {
+        lock_guard<mutex> lock(mutex_);
+        for (size_t i = 0; i < in_use_.size(); i++) {
+            if (!in_use_[i]) {
+                in_use_[i] = true;
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    void release(int slot) {
+        lock_guard<mutex> lock(mutex_);
+        in_use_[static_cast<size_t>(slot)] = false;
+    }
+
+private:
+    mutex mutex_;
+    vector<bool> in_use_;
+};
+
+// Tracks live connection threads so shutdown can unblock and wait for them
+class ConnectionRegistry {
+public:
+    void add(int fd) {
+        lock_guard<mutex> lock(mutex_);
+        fds_.push_back(fd);
+    }
+
+    // Notifies under the lock: shutdown_all() may return and destroy the registry right after
+    void remove(int fd) {
+        lock_guard<mutex> lock(mutex_);
+        fds_.erase(find(fds_.begin(), fds_.end(), fd));
+        cv_.notify_all();
+    }
+
+    void shutdown_all() {
+        unique_lock<mutex> lock(mutex_);
+        for (int fd : fds_) {
+            ::shutdown(fd, SHUT_RDWR);
+        }
+        cv_.wait(lock, [this] { return fds_.empty(); });
+    }
+
+private:
+    mutex mutex_;
+    condition_variable cv_;
+    vector<int> fds_;
+};
+
+TrapResponse verify_one(const SEALContext &context, Decryptor &decryptor, Ciphertext &encrypted,
+                        Plaintext &decrypted, const PendingVerify &item, int baseline_budget, int threshold) {
+    TrapResponse response{};
+    response.magic = TRAP_MAGIC;
+    response.request_id = item.request.request_id;
+    response.status = static_cast<uint32_t>(TrapStatus::ERROR);
+    response.zone = static_cast<uint32_t>(TrapZone::DANGER);
+
+    try {
+        encrypted.load(context, item.data, item.size);
+        TrapVerdict verdict = verify_ciphertext(decryptor, encrypted, decrypted,
+                                                (item.request.flags & TRAP_FLAG_HAS_EXPECTED) != 0,
+                                                item.request.expected_value, baseline_budget, threshold);
+        response.status = static_cast<uint32_t>(verdict.status);
+        response.zone = static_cast<uint32_t>(verdict.zone);
+        response.noise_budget = verdict.noise_budget;
+    } catch (const exception &) {
+        // Malformed or invalid ciphertext: reported as ERROR
+    }
+    return response;
+}
+
+// Each worker owns its decryptor and memory pool; buffers are reused across a batch
+void verify_worker(const SEALContext &context, const SecretKey &secret_key, int baseline_budget, int threshold,
+                   BatchQueue &queue, DaemonStats &stats) {
+    Decryptor decryptor(context, secret_key);
+    MemoryPoolHandle pool = MemoryPoolHandle::New();
+    Ciphertext encrypted(pool);
+    Plaintext decrypted(pool);
+
+    vector<PendingVerify *> batch;
+    while (queue.pop_batch(batch)) {
+        for (auto *item : batch) {
+            TrapResponse response = verify_one(context, decryptor, encrypted, decrypted, *item, baseline_budget, threshold);
+            stats.status_counts[response.status]++;
+            stats.bytes += item->size;
+            item->done.set_value(response);
+        }
+        stats.requests += batch.size();
+        stats.batches++;
+    }
+}
+
+void serve_connection(int fd, BatchQueue &queue, SlotLeases &leases, seal_byte *shm_base, ConnectionRegistry &registry) {
+    int leased_slot = -1;
+    TrapRequest request;
+    while (read_exact(fd, &request, sizeof(request))) {
+        if (request.magic != TRAP_MAGIC) {
+            break;
+        }
+
+        TrapResponse response{};
+        response.magic = TRAP_MAGIC;
+        response.request_id = request.request_id;
+        response.status = static_cast<uint32_t>(TrapStatus::ERROR);
+        response.zone = static_cast<uint32_t>(TrapZone::DANGER);
+
+        if (request.op == TRAP_OP_LEASE_SLOT) {
+            if (shm_base != nullptr && leased_slot < 0) {
+                leased_slot = leases.acquire();
+            }
+            if (leased_slot >= 0) {
+                response.status = static_cast<uint32_t>(TrapStatus::OK);
+                response.slot = static_cast<uint64_t>(leased_slot);
+            }
+        } else if (request.op == TRAP_OP_VERIFY) {
+            PendingVerify pending;
+            pending.request = request;
+            bool valid = true;
+            if (request.flags & TRAP_FLAG_SHM) {
+                // Zero-copy path: the payload is read straight out of the client's slot
+                valid = leased_slot >= 0 && request.shm_slot == static_cast<uint32_t>(leased_slot) &&
+                        request.payload_size <= TRAP_SHM_SLOT_SIZE;
+                if (valid) {
+                    pending.data = shm_base + static_cast<size_t>(leased_slot) * TRAP_SHM_SLOT_SIZE;
+                    pending.size = static_cast<size_t>(request.payload_size);
+                }
+            } else {
+                if (request.payload_size > TRAP_MAX_PAYLOAD) {
+                    break;
+                }
+                pending.payload.resize(static_cast<size_t>(request.payload_size));
+                if (!read_exact(fd, pending.payload.data(), pending.payload.size())) {
+                    break;
+                }
+                pending.data = pending.payload.data();
+                pending.size = pending.payload.size();
+            }
+
+            if (valid) {
+                auto result = pending.done.get_future();
+                queue.push(&pending);
+                response = result.get();
+            }
+        } else {
+            break;
+        }
+
+        if (!write_exact(fd, &response, sizeof(response))) {
+            break;
+        }
+    }
+
+    if (leased_slot >= 0) {
+        leases.release(leased_slot);
+    }
+    close(fd);
+    registry.remove(fd);
+}
+
+// Removes a stale socket left at path by a daemon that is gone. Anything that is not a
+// socket, or a socket another daemon still accepts connections on, is left alone.
+bool clear_socket_path(const string &path, const sockaddr_un &addr) {
+    struct stat st{};
+    if (lstat(path.c_str(), &st) != 0) {
+        if (errno == ENOENT) {
+            return true;
+        }
+        cerr << "Error: cannot stat " << path << ": " << strerror(errno) << endl;
+        return false;
+    }
+    if (!S_ISSOCK(st.st_mode)) {
+        cerr << "Error: " << path << " exists and is not a socket, refusing to remove it" << endl;
+        return false;
+    }
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    bool live = probe >= 0 && connect(probe, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) == 0;
+    if (probe >= 0) {
+        close(probe);
+    }
+    if (live) {
+        cerr << "Error: another daemon is already listening on " << path << endl;
+        return false;
+    }
+    if (unlink(path.c_str()) != 0 && errno != ENOENT) {
+        cerr << "Error: cannot remove stale socket " << path << ": " << strerror(errno) << endl;
+        return false;
+    }
+    return true;
+}
+
+DaemonOptions parse_options(int argc, char **argv) {
+    DaemonOptions options;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        auto next = [&]() -> string {
+            if (i + 1 >= argc) throw invalid_argument("missing value for " + arg);
+            return argv[++i];
+        };
+        if (arg == "--socket") options.socket_path = next();
+        else if (arg == "--keys") options.key_dir = next();
+        else if (arg == "--batch") options.max_batch = stoul(next());
+        else if (arg == "--workers") options.workers = stoul(next());
+        else if (arg == "--threshold") options.threshold = stoi(next());
+        else if (arg == "--no-shm") options.use_shm = false;
+        else throw invalid_argument("unknown option " + arg);
+    }
+    if (options.max_batch == 0) options.max_batch = 1;
+    if (options.workers == 0) options.workers = max(1u, thread::hardware_concurrency());
+    return options;
+}
+
+int main(int argc, char **argv) {
+    DaemonOptions options;
+    try {
+        options = parse_options(argc, argv);
+    } catch (const exception &e) {
+        cerr << "Error: " << e.what() << endl;
+        cerr << "Usage: overflow_trap_daemon [--socket PATH] [--keys DIR] [--batch N]"
+             << " [--workers N] [--threshold BITS] [--no-shm]" << endl;
+        return 1;
+    }
+
+    // Load (or create) the context and keys once
+    EncryptionParameters parms = load_or_create_trap_parameters(options.key_dir);
+    SEALContext context(parms, true);
+    if (!context.parameters_set()) {
+        cerr << "Error: invalid encryption parameters: " << context.parameter_error_message() << endl;
+        return 1;
+    }
+    print_trap_parameters(context);
+    SecretKey secret_key = load_or_create_trap_secret_key(context, options.key_dir);
+    PublicKey public_key = load_trap_public_key(context, options.key_dir);
+
+    // Baseline is the budget of a fresh public-key encryption, as clients produce them
+    Encryptor encryptor(context, public_key);
+    Decryptor decryptor(context, secret_key);
+    Plaintext fresh_plain("1");
+    Ciphertext fresh;
+    encryptor.encrypt(fresh_plain, fresh);
+    int baseline_budget = decryptor.invariant_noise_budget(fresh);
+    int threshold = options.threshold >= 0 ? options.threshold : danger_threshold(baseline_budget);
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (options.socket_path.size() >= sizeof(addr.sun_path)) {
+        cerr << "Error: socket path too long" << endl;
+        return 1;
+    }
+    strncpy(addr.sun_path, options.socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    if (!clear_socket_path(options.socket_path, addr)) {
+        return 1;
+    }
+    if (listen_fd < 0 || ::bind(listen_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+        listen(listen_fd, 128) != 0) {
+        cerr << "Error: cannot listen on " << options.socket_path << ": " << strerror(errno) << endl;
+        return 1;
+    }
+
+    // Optional shared-memory ring for zero-copy payloads. The socket is ours now, so a ring
+    // under its name was left by a daemon that died; anything else fails O_EXCL.
+    string shm_name = trap_shm_name(options.socket_path);
+    seal_byte *shm_base = nullptr;
+    size_t shm_bytes = TRAP_SHM_SLOT_COUNT * TRAP_SHM_SLOT_SIZE;
+    if (options.use_shm) {
+        shm_unlink(shm_name.c_str());
+        int shm_fd = shm_open(shm_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (shm_fd < 0 && errno == EEXIST) {
+            cerr << "Error: shared-memory ring " << shm_name << " already exists" << endl;
+            close(listen_fd);
+            unlink(options.socket_path.c_str());
+            return 1;
+        }
+        if (shm_fd >= 0 && ftruncate(shm_fd, static_cast<off_t>(shm_bytes)) == 0) {
+            void *mapped = mmap(nullptr, shm_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+            if (mapped != MAP_FAILED) {
+                shm_base = static_cast<seal_byte *>(mapped);
+            }
+        }
+        if (shm_fd >= 0) {
+            close(shm_fd);
+        }
+        if (shm_base == nullptr) {
+            cerr << "Warning: shared-memory ring unavailable (" << strerror(errno) << "), socket payloads only" << endl;
+            shm_unlink(shm_name.c_str());
+        }
+    }
+
+    struct sigaction action{};
+    action.sa_handler = handle_stop_signal;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+
+    cout << "\nOverflow trap daemon" << endl;
+    cout << string(100, '-') << endl;
+    cout << "- Socket: " << options.socket_path << endl;
+    cout << "- Shared-memory ring: " << (shm_base ? shm_name + " (" + to_string(TRAP_SHM_SLOT_COUNT) +
+                                                        " slots x " + to_string(TRAP_SHM_SLOT_SIZE >> 20) + " MiB)"
+                                               : string("disabled")) << endl;
+    cout << "- Baseline noise budget: " << baseline_budget << " bits" << endl;
+    cout << "- Danger threshold: " << threshold << " bits" << endl;
+    cout << "- Batching: backlog shared across idle workers, up to " << options.max_batch << " requests per batch" << endl;
+    cout << "- Verification workers: " << options.workers << endl;
+    cout << string(100, '-') << endl;
+
+    BatchQueue queue(options.max_batch);
+    SlotLeases leases(TRAP_SHM_SLOT_COUNT);
+    ConnectionRegistry registry;
+    DaemonStats stats;
+
+    vector<thread> workers;
+    for (size_t i = 0; i < options.workers; i++) {
+        workers.emplace_back(verify_worker, cref(context), cref(secret_key), baseline_budget, threshold, ref(queue), ref(stats));
+    }
+
+    auto last_report = chrono::steady_clock::now();
+    uint64_t last_requests = 0;
+    while (!stop_requested) {
+        pollfd pfd{listen_fd, POLLIN, 0};
+        int ready = poll(&pfd, 1, 200);
+        if (ready > 0 && (pfd.revents & POLLIN)) {
+            int fd = accept(listen_fd, nullptr, nullptr);
+            if (fd >= 0) {
+                registry.add(fd);
+                thread(serve_connection, fd, ref(queue), ref(leases), shm_base, ref(registry)).detach();
+            }
+        }
+
+        auto now = chrono::steady_clock::now();
+        if (now - last_report >= chrono::seconds(5)) {
+            uint64_t requests = stats.requests.load();
+            uint64_t batches = stats.batches.load();
+            if (requests != last_requests) {
+                double seconds = chrono::duration<double>(now - last_report).count();
+                cout << "[stats] " << fixed << setprecision(1) << (requests - last_requests) / seconds << " req/s, "
+                     << "avg batch " << (batches > 0 ? static_cast<double>(requests) / batches : 0.0) << ", "
+                     << requests << " total" << endl;
+            }
+            last_requests = requests;
+            last_report = now;
+        }
+    }
+
+    cout << "\nShutting down..." << endl;
+    close(listen_fd);
+    unlink(options.socket_path.c_str());
+    registry.shutdown_all();
+    queue.close();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    if (shm_base != nullptr) {
+        munmap(shm_base, shm_bytes);
+        shm_unlink(shm_name.c_str());
+    }
+
+    uint64_t batches = stats.batches.load();
+    cout << "\nDaemon Summary:" << endl;
+    cout << "1. Requests verified: " << stats.requests.load() << endl;
+    cout << "2. Batches: " << batches << " (avg " << fixed << setprecision(1)
+         << (batches > 0 ? static_cast<double>(stats.requests.load()) / batches : 0.0) << " per batch)" << endl;
+    cout << "3. Payload bytes: " << stats.bytes.load() << endl;
+    cout << "4. Status counts: OK=" << stats.status_counts[0].load()
+         << " DANGER=" << stats.status_counts[1].load()
+         << " CORRUPTED=" << stats.status_counts[2].load()
+         << " ERROR=" << stats.status_counts[3].load() << endl;
+
+    return 0;
+}
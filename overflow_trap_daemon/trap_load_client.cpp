@@ -0,0 +1,232 @@
+#include "trap_protocol.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iomanip>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace seal;
+
+// Load generator for overflow_trap_daemon: opens concurrent connections, streams
+// serialized ciphertexts at the daemon and reports throughput and latency percentiles.
+
+struct ClientOptions {
+    string socket_path = "/tmp/overflow_trap.sock";
+    string key_dir = "trap_keys";
+    size_t connections = 8;
+    size_t requests = 200; // per connection
+    bool use_shm = false;
+};
+
+struct Sample {
+    string label;
+    vector<seal_byte> bytes;
+    uint64_t expected;
+};
+
+struct ConnectionResult {
+    vector<double> latencies_us;
+    uint64_t status_counts[4] = {};
+    uint64_t bytes = 0;
+    bool failed = false;
+};
+
+int connect_to_daemon(const string &socket_path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+Sample make_sample(const string &label, const Ciphertext &encrypted, uint64_t expected) {
+    // Uncompressed so the daemon measures verification, not decompression
+    Sample sample{label, vector<seal_byte>(static_cast<size_t>(encrypted.save_size(compr_mode_type::none))), expected};
+    size_t written = static_cast<size_t>(encrypted.save(sample.bytes.data(), sample.bytes.size(), compr_mode_type::none));
+    sample.bytes.resize(written);
+    return sample;
+}
+
+void run_connection(const ClientOptions &options, const vector<Sample> &samples, size_t connection_index,
+                    seal_byte *shm_base, ConnectionResult &result) {
+    int fd = connect_to_daemon(options.socket_path);
+    if (fd < 0) {
+        result.failed = true;
+        return;
+    }
+
+    uint32_t slot = 0;
+    if (options.use_shm) {
+        TrapRequest lease{TRAP_MAGIC, TRAP_OP_LEASE_SLOT, 0, 0, 0, 0, 0};
+        TrapResponse response;
+        if (!write_exact(fd, &lease, sizeof(lease)) || !read_exact(fd, &response, sizeof(response)) ||
+            response.status != static_cast<uint32_t>(TrapStatus::OK)) {
+            result.failed = true;
+            close(fd);
+            return;
+        }
+        slot = static_cast<uint32_t>(response.slot);
+    }
+
+    result.latencies_us.reserve(options.requests);
+    for (size_t i = 0; i < options.requests; i++) {
+        const Sample &sample = samples[(connection_index + i) % samples.size()];
+        TrapRequest request{TRAP_MAGIC, TRAP_OP_VERIFY, TRAP_FLAG_HAS_EXPECTED, slot,
+                            connection_index * options.requests + i, sample.expected, sample.bytes.size()};
+
+        auto start = chrono::steady_clock::now();
+        bool sent;
+        if (options.use_shm) {
+            request.flags |= TRAP_FLAG_SHM;
+            memcpy(shm_base + static_cast<size_t>(slot) * TRAP_SHM_SLOT_SIZE, sample.bytes.data(), sample.bytes.size());
+            sent = write_exact(fd, &request, sizeof(request));
+        } else {
+            sent = write_exact(fd, &request, sizeof(request)) && write_exact(fd, sample.bytes.data(), sample.bytes.size());
+        }
+        TrapResponse response;
+        if (!sent || !read_exact(fd, &response, sizeof(response)) || response.magic != TRAP_MAGIC) {
+            result.failed = true;
+            break;
+        }
+        auto end = chrono::steady_clock::now();
+
+        result.latencies_us.push_back(chrono::duration<double, micro>(end - start).count());
+        result.status_counts[min<uint32_t>(response.status, 3)]++;
+        result.bytes += sample.bytes.size();
+    }
+    close(fd);
+}
+
+double percentile(const vector<double> &sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[min(index, sorted.size() - 1)];
+}
+
+int main(int argc, char **argv) {
+    ClientOptions options;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) options.socket_path = argv[++i];
+        else if (arg == "--keys" && i + 1 < argc) options.key_dir = argv[++i];
+        else if (arg == "--connections" && i + 1 < argc) options.connections = stoul(argv[++i]);
+        else if (arg == "--requests" && i + 1 < argc) options.requests = stoul(argv[++i]);
+        else if (arg == "--shm") options.use_shm = true;
+        else {
+            cerr << "Usage: trap_load_client [--socket PATH] [--keys DIR] [--connections N] [--requests N] [--shm]" << endl;
+            return 1;
+        }
+    }
+
+    // Untrusted side: parameters and public key only
+    EncryptionParameters parms = load_trap_parameters(options.key_dir);
+    SEALContext context(parms, true);
+    print_trap_parameters(context);
+    PublicKey public_key = load_trap_public_key(context, options.key_dir);
+    Encryptor encryptor(context, public_key);
+    Evaluator evaluator(context);
+
+    // Workload mirrors overflow_trap_demo: fresh operands, 100 × 10, and a multiply-by-1 attack
+    Plaintext plain1("64"), plain2("A"), one_plain("1"); // hex: 100, 10, 1
+    Ciphertext encrypted1, encrypted2, encrypted_one;
+    encryptor.encrypt(plain1, encrypted1);
+    encryptor.encrypt(plain2, encrypted2);
+    encryptor.encrypt(one_plain, encrypted_one);
+    Ciphertext mult_result;
+    evaluator.multiply(encrypted1, encrypted2, mult_result);
+    Ciphertext attacked = mult_result;
+    for (int i = 0; i < 3; i++) {
+        evaluator.multiply_inplace(attacked, encrypted_one);
+    }
+
+    vector<Sample> samples;
+    samples.push_back(make_sample("Fresh 100", encrypted1, 100));
+    samples.push_back(make_sample("100 × 10", mult_result, 1000));
+    samples.push_back(make_sample("Mult Attack #3", attacked, 1000));
+
+    seal_byte *shm_base = nullptr;
+    size_t shm_bytes = TRAP_SHM_SLOT_COUNT * TRAP_SHM_SLOT_SIZE;
+    if (options.use_shm) {
+        for (const auto &sample : samples) {
+            if (sample.bytes.size() > TRAP_SHM_SLOT_SIZE) {
+                cerr << "Error: " << sample.label << " does not fit in a shared-memory slot" << endl;
+                return 1;
+            }
+        }
+        string shm_name = trap_shm_name(options.socket_path);
+        int shm_fd = shm_open(shm_name.c_str(), O_RDWR, 0600);
+        void *mapped = shm_fd >= 0 ? mmap(nullptr, shm_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0) : MAP_FAILED;
+        if (shm_fd >= 0) {
+            close(shm_fd);
+        }
+        if (mapped == MAP_FAILED) {
+            cerr << "Error: cannot map " << shm_name << " (is the daemon running with shm enabled?)" << endl;
+            return 1;
+        }
+        shm_base = static_cast<seal_byte *>(mapped);
+    }
+
+    cout << "\nLoad test: " << options.connections << " connections × " << options.requests << " requests"
+         << (options.use_shm ? " (shared-memory payloads)" : " (socket payloads)") << endl;
+    cout << string(100, '-') << endl;
+    cout << setw(20) << "Sample" << setw(20) << "Payload" << setw(15) << "Expected" << endl;
+    for (const auto &sample : samples) {
+        cout << setw(20) << sample.label << setw(20) << to_string(sample.bytes.size()) + " bytes"
+             << setw(15) << sample.expected << endl;
+    }
+    cout << string(100, '-') << endl;
+
+    vector<ConnectionResult> results(options.connections);
+    vector<thread> threads;
+    auto start = chrono::steady_clock::now();
+    for (size_t c = 0; c < options.connections; c++) {
+        threads.emplace_back(run_connection, cref(options), cref(samples), c, shm_base, ref(results[c]));
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    vector<double> latencies;
+    uint64_t status_counts[4] = {};
+    uint64_t bytes = 0;
+    size_t failed = 0;
+    for (const auto &result : results) {
+        latencies.insert(latencies.end(), result.latencies_us.begin(), result.latencies_us.end());
+        for (int s = 0; s < 4; s++) status_counts[s] += result.status_counts[s];
+        bytes += result.bytes;
+        failed += result.failed ? 1 : 0;
+    }
+    sort(latencies.begin(), latencies.end());
+
+    if (shm_base != nullptr) {
+        munmap(shm_base, shm_bytes);
+    }
+
+    cout << "\nLoad Test Results:" << endl;
+    cout << "1. Completed requests: " << latencies.size() << " in " << fixed << setprecision(2) << elapsed << " s"
+         << (failed > 0 ? " (" + to_string(failed) + " connections failed)" : "") << endl;
+    cout << "2. Throughput: " << setprecision(1) << latencies.size() / elapsed << " ciphertexts/s, "
+         << bytes / elapsed / (1 << 20) << " MiB/s" << endl;
+    cout << "3. Latency: p50 " << percentile(latencies, 0.50) << " us, p99 " << percentile(latencies, 0.99)
+         << " us, max " << (latencies.empty() ? 0.0 : latencies.back()) << " us" << endl;
+    cout << "4. Status counts: OK=" << status_counts[0] << " DANGER=" << status_counts[1]
+         << " CORRUPTED=" << status_counts[2] << " ERROR=" << status_counts[3] << endl;
+
+    return failed == options.connections ? 1 : 0;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "trap_common/trap_common.h"
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+
+// Wire protocol between overflow_trap_daemon and its clients over a Unix domain socket.
+// Every message is a fixed-size header in host byte order (both ends are local).
+//
+//   TRAP_OP_VERIFY:      header, then payload_size bytes of a serialized Ciphertext
+//                        (unless TRAP_FLAG_SHM is set, in which case the payload already
+//                        sits in the leased shared-memory slot and nothing follows)
+//   TRAP_OP_LEASE_SLOT:  header only; the response carries the leased slot index in slot
+//
+// The daemon answers every request with exactly one TrapResponse. A VERIFY response carries
+// status, noise budget and zone only: clients hold just the public key, so the daemon never
+// sends decrypted data back (CORRUPTED is decided against the client's expected_value).
+
+constexpr uint32_t TRAP_MAGIC = 0x50415254; // "TRAP"
+
+constexpr uint32_t TRAP_OP_VERIFY = 1;
+constexpr uint32_t TRAP_OP_LEASE_SLOT = 2;
+
+constexpr uint32_t TRAP_FLAG_HAS_EXPECTED = 1u << 0;
+constexpr uint32_t TRAP_FLAG_SHM = 1u << 1;
+
+// Shared-memory ring: fixed-size slots, one leased per connection
+constexpr size_t TRAP_SHM_SLOT_COUNT = 64;
+constexpr size_t TRAP_SHM_SLOT_SIZE = 2u << 20; // fits an unrelinearized size-3 ciphertext at n = 8192
+
+// The ring is named after the daemon's socket (FNV-1a of the absolute path), so daemons
+// on different sockets never map the same ring
+inline std::string trap_shm_name(const std::string &socket_path) {
+    std::string key = std::filesystem::absolute(socket_path).lexically_normal().string();
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : key) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    char name[40];
+    std::snprintf(name, sizeof(name), "/overflow_trap_ring_%016llx", static_cast<unsigned long long>(hash));
+    return name;
+}
+
+// Upper bound on a socket payload, guards against a bogus payload_size
+constexpr uint64_t TRAP_MAX_PAYLOAD = 64u << 20;
+
+struct TrapRequest {
+    uint32_t magic;
+    uint32_t op;
+    uint32_t flags;
+    uint32_t shm_slot;
+    uint64_t request_id;
+    uint64_t expected_value;
+    uint64_t payload_size;
+};
+
+struct TrapResponse {
+    uint32_t magic;
+    uint32_t status;   // TrapStatus
+    uint32_t zone;     // TrapZone
+    int32_t noise_budget;
+    uint64_t request_id;
+    uint64_t slot;     // leased slot index for TRAP_OP_LEASE_SLOT, 0 otherwise
+};
+
+// Blocking full-length read/write; false on EOF or error
+inline bool read_exact(int fd, void *buffer, size_t size) {
+    auto *ptr = static_cast<char *>(buffer);
+    while (size > 0) {
+        ssize_t n = ::read(fd, ptr, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        ptr += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+inline bool write_exact(int fd, const void *buffer, size_t size) {
+    auto *ptr = static_cast<const char *>(buffer);
+    while (size > 0) {
+        ssize_t n = ::write(fd, ptr, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        ptr += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
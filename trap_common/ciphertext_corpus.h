@@ -0,0 +1,269 @@
+#pragma once
+
+#include "seal/seal.h"
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+// Ciphertext corpus: a flat file of raw ciphertext polynomial data for large batch scans.
+//
+//   CorpusHeader                       magic, parms_id, geometry, entry count
+//   CorpusEntry[count]                 per-entry offset, polynomial count, expected value,
+//                                      ciphertext metadata (NTT form, BGV correction factor, CKKS scale)
+//   (padding to CORPUS_DATA_ALIGNMENT)
+//   entry data, each CORPUS_ENTRY_ALIGNMENT-aligned:
+//     size * coeff_modulus_size * poly_modulus_degree uint64_t coefficients, exactly
+//     the layout of Ciphertext::data()
+//
+// There is no per-entry SEAL serialization to parse: the reader maps the file and either
+// hands out raw polynomial views or copies an entry into a caller-owned (pooled) Ciphertext.
+// Every entry shares the header's parms_id; all numbers are in host byte order.
+
+constexpr char CORPUS_MAGIC[8] = {'S', 'E', 'A', 'L', 'C', 'R', 'P', '1'};
+constexpr uint32_t CORPUS_VERSION = 2; // 2: correction factor and scale per entry
+constexpr uint64_t CORPUS_DATA_ALIGNMENT = 4096; // page-aligned so entries can be mapped and dropped
+constexpr uint64_t CORPUS_ENTRY_ALIGNMENT = 64;  // cache-line aligned polynomial data
+
+constexpr uint32_t CORPUS_ENTRY_HAS_EXPECTED = 1u << 0;
+constexpr uint32_t CORPUS_ENTRY_NTT_FORM = 1u << 1;
+
+struct CorpusHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t count;
+    uint64_t parms_id[4];
+    uint64_t poly_modulus_degree;
+    uint64_t coeff_modulus_size;
+    uint64_t data_offset;
+};
+
+struct CorpusEntry {
+    uint64_t offset; // from the start of the file
+    uint64_t size;   // number of polynomials
+    uint64_t expected_value;
+    uint32_t flags;
+    uint32_t reserved;
+    uint64_t correction_factor; // Ciphertext::correction_factor() (BGV)
+    double scale;               // Ciphertext::scale() (CKKS)
+};
+
+inline uint64_t corpus_align_up(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Streams ciphertexts to disk without holding them in memory. The entry count is fixed
+// up front so the index can be reserved; header and index are written by finish().
+class CorpusWriter {
+public:
+    CorpusWriter(const std::string &path, const seal::SEALContext &context, const seal::parms_id_type &parms_id,
+                 uint64_t count)
+        : out_(path, std::ios::binary | std::ios::trunc), parms_id_(parms_id) {
+        auto context_data = context.get_context_data(parms_id);
+        if (!out_) {
+            throw std::runtime_error("cannot open " + path);
+        }
+        if (!context_data) {
+            throw std::invalid_argument("parms_id is not valid for the context");
+        }
+        std::memcpy(header_.magic, CORPUS_MAGIC, sizeof(header_.magic));
+        header_.version = CORPUS_VERSION;
+        header_.reserved = 0;
+        header_.count = count;
+        std::memcpy(header_.parms_id, parms_id.data(), sizeof(header_.parms_id));
+        header_.poly_modulus_degree = context_data->parms().poly_modulus_degree();
+        header_.coeff_modulus_size = context_data->parms().coeff_modulus().size();
+        header_.data_offset = corpus_align_up(sizeof(CorpusHeader) + count * sizeof(CorpusEntry), CORPUS_DATA_ALIGNMENT);
+        entries_.reserve(static_cast<size_t>(count));
+        position_ = header_.data_offset;
+    }
+
+    ~CorpusWriter() {
+        try {
+            finish();
+        } catch (...) {
+        }
+    }
+
+    CorpusWriter(const CorpusWriter &) = delete;
+    CorpusWriter &operator=(const CorpusWriter &) = delete;
+
+    void append(const seal::Ciphertext &encrypted, bool has_expected = false, uint64_t expected_value = 0) {
+        if (entries_.size() >= header_.count) {
+            throw std::logic_error("corpus is full");
+        }
+        if (encrypted.parms_id() != parms_id_) {
+            throw std::invalid_argument("ciphertext parms_id does not match the corpus");
+        }
+        uint64_t bytes = static_cast<uint64_t>(encrypted.size()) * header_.coeff_modulus_size *
+                         header_.poly_modulus_degree * sizeof(uint64_t);
+        position_ = corpus_align_up(position_, CORPUS_ENTRY_ALIGNMENT);
+        out_.seekp(static_cast<std::streamoff>(position_));
+        out_.write(reinterpret_cast<const char *>(encrypted.data()), static_cast<std::streamsize>(bytes));
+        if (!out_) {
+            throw std::runtime_error("corpus write failed");
+        }
+
+        CorpusEntry entry{};
+        entry.offset = position_;
+        entry.size = encrypted.size();
+        entry.expected_value = expected_value;
+        entry.flags = (has_expected ? CORPUS_ENTRY_HAS_EXPECTED : 0) | (encrypted.is_ntt_form() ? CORPUS_ENTRY_NTT_FORM : 0);
+        entry.correction_factor = encrypted.correction_factor();
+        entry.scale = encrypted.scale();
+        entries_.push_back(entry);
+        position_ += bytes;
+    }
+
+    // Writes header and index; the header records the number of entries actually appended
+    void finish() {
+        if (finished_) {
+            return;
+        }
+        finished_ = true;
+        header_.count = entries_.size();
+        out_.seekp(0);
+        out_.write(reinterpret_cast<const char *>(&header_), sizeof(header_));
+        out_.write(reinterpret_cast<const char *>(entries_.data()),
+                   static_cast<std::streamsize>(entries_.size() * sizeof(CorpusEntry)));
+        out_.close();
+        if (!out_) {
+            throw std::runtime_error("corpus write failed");
+        }
+    }
+
+    uint64_t bytes_written() const { return position_; }
+
+private:
+    std::ofstream out_;
+    seal::parms_id_type parms_id_;
+    CorpusHeader header_{};
+    std::vector<CorpusEntry> entries_;
+    uint64_t position_ = 0;
+    bool finished_ = false;
+};
+
+// Read-only mmap of a corpus. Pages are faulted in on demand, so corpora larger than RAM
+// can be streamed; callers use advise_* to read ahead and to drop what they are done with.
+class CorpusReader {
+public:
+    explicit CorpusReader(const std::string &path) {
+        fd_ = ::open(path.c_str(), O_RDONLY);
+        if (fd_ < 0) {
+            throw std::runtime_error("cannot open " + path);
+        }
+        struct stat st{};
+        if (fstat(fd_, &st) != 0 || static_cast<uint64_t>(st.st_size) < sizeof(CorpusHeader)) {
+            ::close(fd_);
+            throw std::runtime_error(path + " is not a ciphertext corpus");
+        }
+        size_ = static_cast<uint64_t>(st.st_size);
+        void *mapped = mmap(nullptr, static_cast<size_t>(size_), PROT_READ, MAP_SHARED, fd_, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd_);
+            throw std::runtime_error("cannot map " + path);
+        }
+        base_ = static_cast<const unsigned char *>(mapped);
+        madvise(const_cast<unsigned char *>(base_), static_cast<size_t>(size_), MADV_SEQUENTIAL);
+
+        header_ = reinterpret_cast<const CorpusHeader *>(base_);
+        entries_ = reinterpret_cast<const CorpusEntry *>(base_ + sizeof(CorpusHeader));
+        if (std::memcmp(header_->magic, CORPUS_MAGIC, sizeof(CORPUS_MAGIC)) != 0 || header_->version != CORPUS_VERSION ||
+            header_->poly_modulus_degree > SEAL_POLY_MOD_DEGREE_MAX ||
+            header_->coeff_modulus_size > SEAL_COEFF_MOD_COUNT_MAX ||
+            header_->count > (size_ - sizeof(CorpusHeader)) / sizeof(CorpusEntry)) {
+            unmap();
+            throw std::runtime_error(path + " is not a ciphertext corpus");
+        }
+        for (uint64_t i = 0; i < header_->count; i++) {
+            if (entries_[i].size < SEAL_CIPHERTEXT_SIZE_MIN || entries_[i].size > SEAL_CIPHERTEXT_SIZE_MAX ||
+                entries_[i].offset % CORPUS_ENTRY_ALIGNMENT != 0 || entries_[i].offset > size_ ||
+                entry_bytes(i) > size_ - entries_[i].offset) {
+                unmap();
+                throw std::runtime_error(path + ": entry " + std::to_string(i) + " is out of bounds");
+            }
+        }
+    }
+
+    ~CorpusReader() { unmap(); }
+
+    CorpusReader(const CorpusReader &) = delete;
+    CorpusReader &operator=(const CorpusReader &) = delete;
+
+    const CorpusHeader &header() const { return *header_; }
+
+    uint64_t count() const { return header_->count; }
+
+    uint64_t file_size() const { return size_; }
+
+    seal::parms_id_type parms_id() const {
+        seal::parms_id_type parms_id;
+        std::memcpy(parms_id.data(), header_->parms_id, sizeof(header_->parms_id));
+        return parms_id;
+    }
+
+    const CorpusEntry &entry(uint64_t index) const { return entries_[index]; }
+
+    uint64_t entry_bytes(uint64_t index) const {
+        return entries_[index].size * header_->coeff_modulus_size * header_->poly_modulus_degree * sizeof(uint64_t);
+    }
+
+    // Zero-copy view of polynomial poly_index of an entry (coeff_modulus_size * n coefficients)
+    const uint64_t *poly_view(uint64_t index, size_t poly_index) const {
+        return reinterpret_cast<const uint64_t *>(base_ + entries_[index].offset) +
+               poly_index * header_->coeff_modulus_size * header_->poly_modulus_degree;
+    }
+
+    // Copies an entry into destination, reusing its allocation when the size allows.
+    // SEAL ciphertexts own their storage, so this is one memcpy out of the page cache.
+    void load(const seal::SEALContext &context, uint64_t index, seal::Ciphertext &destination) const {
+        const CorpusEntry &e = entries_[index];
+        destination.resize(context, parms_id(), static_cast<size_t>(e.size));
+        destination.is_ntt_form() = (e.flags & CORPUS_ENTRY_NTT_FORM) != 0;
+        destination.correction_factor() = e.correction_factor;
+        destination.scale() = e.scale;
+        std::memcpy(destination.data(), base_ + e.offset, static_cast<size_t>(entry_bytes(index)));
+        if (!seal::is_data_valid_for(destination, context)) {
+            throw std::logic_error("corpus entry " + std::to_string(index) + " has out-of-range coefficients");
+        }
+    }
+
+    // Hints for entries [first, last): start reading them in, or drop their pages
+    void advise_willneed(uint64_t first, uint64_t last) const { advise(first, last, MADV_WILLNEED); }
+
+    void advise_dontneed(uint64_t first, uint64_t last) const { advise(first, last, MADV_DONTNEED); }
+
+private:
+    void advise(uint64_t first, uint64_t last, int advice) const {
+        if (first >= last || last > header_->count) {
+            return;
+        }
+        uint64_t begin = entries_[first].offset / CORPUS_DATA_ALIGNMENT * CORPUS_DATA_ALIGNMENT;
+        uint64_t end = entries_[last - 1].offset + entry_bytes(last - 1);
+        madvise(const_cast<unsigned char *>(base_) + begin, static_cast<size_t>(end - begin), advice);
+    }
+
+    void unmap() {
+        if (base_ != nullptr) {
+            munmap(const_cast<unsigned char *>(base_), static_cast<size_t>(size_));
+            base_ = nullptr;
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    int fd_ = -1;
+    uint64_t size_ = 0;
+    const unsigned char *base_ = nullptr;
+    const CorpusHeader *header_ = nullptr;
+    const CorpusEntry *entries_ = nullptr;
+};
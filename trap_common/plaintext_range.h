@@ -0,0 +1,322 @@
+#pragma once
+
+#include "seal/seal.h"
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Plaintext-range tracking: a shadow of per-slot value bounds carried alongside each
+// monitored ciphertext. Bounds are propagated through add/sub/multiply/multiply_plain
+// on the true (unreduced) integers, so a wrap modulo the plain modulus p is flagged
+// before the homomorphic operation runs, without any secret-key operation.
+
+// 128-bit shadow arithmetic, saturating at +/-2^125 so it can never overflow itself:
+// the sum or difference of two saturated values is at most 2^126 in magnitude
+using wide_int = __int128;
+
+constexpr wide_int WIDE_LIMIT = static_cast<wide_int>(1) << 125;
+
+inline wide_int saturate(wide_int value) {
+    return std::max(-WIDE_LIMIT, std::min(WIDE_LIMIT, value));
+}
+
+inline wide_int saturating_add(wide_int a, wide_int b) {
+    return saturate(saturate(a) + saturate(b));
+}
+
+inline wide_int saturating_sub(wide_int a, wide_int b) {
+    return saturate(saturate(a) - saturate(b));
+}
+
+inline wide_int saturating_mul(wide_int a, wide_int b) {
+    a = saturate(a);
+    b = saturate(b);
+    if (a == 0 || b == 0) return 0;
+    wide_int abs_a = a < 0 ? -a : a;
+    wide_int abs_b = b < 0 ? -b : b;
+    bool negative = (a < 0) != (b < 0);
+    if (abs_a > WIDE_LIMIT / abs_b) return negative ? -WIDE_LIMIT : WIDE_LIMIT;
+    return negative ? -(abs_a * abs_b) : abs_a * abs_b;
+}
+
+inline bool is_saturated(wide_int value) {
+    return value >= WIDE_LIMIT || value <= -WIDE_LIMIT;
+}
+
+inline std::string wide_to_string(wide_int value) {
+    if (value >= WIDE_LIMIT) return ">=2^125";
+    if (value <= -WIDE_LIMIT) return "<=-2^125";
+    if (value == 0) return "0";
+    bool negative = value < 0;
+    if (negative) value = -value;
+    std::string digits;
+    while (value > 0) {
+        digits.push_back(static_cast<char>('0' + static_cast<int>(value % 10)));
+        value /= 10;
+    }
+    if (negative) digits.push_back('-');
+    return std::string(digits.rbegin(), digits.rend());
+}
+
+struct ValueRange {
+    wide_int lo = 0;
+    wide_int hi = 0;
+
+    static ValueRange exact(wide_int value) { return {value, value}; }
+
+    bool is_zero() const { return lo == 0 && hi == 0; }
+
+    // Decryption yields representatives in [0, p); anything else has wrapped
+    bool fits(uint64_t plain_modulus) const {
+        return lo >= 0 && hi < static_cast<wide_int>(plain_modulus);
+    }
+
+    friend ValueRange operator+(const ValueRange &a, const ValueRange &b) {
+        return {saturating_add(a.lo, b.lo), saturating_add(a.hi, b.hi)};
+    }
+
+    friend ValueRange operator-(const ValueRange &a, const ValueRange &b) {
+        return {saturating_sub(a.lo, b.hi), saturating_sub(a.hi, b.lo)};
+    }
+
+    friend ValueRange operator*(const ValueRange &a, const ValueRange &b) {
+        wide_int p1 = saturating_mul(a.lo, b.lo);
+        wide_int p2 = saturating_mul(a.lo, b.hi);
+        wide_int p3 = saturating_mul(a.hi, b.lo);
+        wide_int p4 = saturating_mul(a.hi, b.hi);
+        return {std::min({p1, p2, p3, p4}), std::max({p1, p2, p3, p4})};
+    }
+};
+
+// COEFFICIENT: values live in polynomial coefficients (plain[i], as in the demos), so a
+//              ciphertext product is a negacyclic convolution of the coefficient ranges.
+// BATCH:       values live in BatchEncoder slots and every operation is slot-wise.
+enum class PlainEncoding { COEFFICIENT, BATCH };
+
+class PlaintextRange {
+public:
+    PlaintextRange() = default;
+
+    // Every slot holds exactly the given value (missing trailing slots are zero)
+    static PlaintextRange exact(PlainEncoding encoding, uint64_t plain_modulus, size_t slot_count,
+                                const std::vector<uint64_t> &values) {
+        PlaintextRange range(encoding, plain_modulus, slot_count);
+        range.ranges_.resize(encoding == PlainEncoding::BATCH ? slot_count : std::min(values.size(), slot_count));
+        for (size_t i = 0; i < std::min(values.size(), slot_count); i++) {
+            range.ranges_[i] = ValueRange::exact(values[i]);
+        }
+        range.trim();
+        return range;
+    }
+
+    // Every slot lies somewhere in bound (e.g. inputs only known to be 8-bit)
+    static PlaintextRange bounded(PlainEncoding encoding, uint64_t plain_modulus, size_t slot_count, ValueRange bound) {
+        PlaintextRange range(encoding, plain_modulus, slot_count);
+        range.ranges_.assign(slot_count, bound);
+        range.trim();
+        return range;
+    }
+
+    // Exact range of a coefficient-encoded plaintext, read directly from its coefficients
+    static PlaintextRange from_coefficients(const seal::Plaintext &plain, uint64_t plain_modulus, size_t slot_count) {
+        std::vector<uint64_t> values(plain.coeff_count());
+        for (size_t i = 0; i < values.size(); i++) {
+            values[i] = plain[i];
+        }
+        return exact(PlainEncoding::COEFFICIENT, plain_modulus, slot_count, values);
+    }
+
+    friend PlaintextRange operator+(const PlaintextRange &a, const PlaintextRange &b) {
+        return elementwise(a, b, [](const ValueRange &x, const ValueRange &y) { return x + y; });
+    }
+
+    friend PlaintextRange operator-(const PlaintextRange &a, const PlaintextRange &b) {
+        return elementwise(a, b, [](const ValueRange &x, const ValueRange &y) { return x - y; });
+    }
+
+    friend PlaintextRange operator*(const PlaintextRange &a, const PlaintextRange &b) {
+        if (a.encoding_ == PlainEncoding::BATCH) {
+            return elementwise(a, b, [](const ValueRange &x, const ValueRange &y) { return x * y; });
+        }
+
+        // Negacyclic convolution in Z[x]/(x^n + 1): x^n wraps around to -1.
+        // Only the non-zero prefixes are stored, so this is O(deg(a) * deg(b)).
+        PlaintextRange result(a.encoding_, a.plain_modulus_, a.slot_count_);
+        if (a.ranges_.empty() || b.ranges_.empty()) {
+            return result;
+        }
+        size_t n = a.slot_count_;
+        result.ranges_.assign(std::min(a.ranges_.size() + b.ranges_.size() - 1, n), ValueRange{});
+        for (size_t i = 0; i < a.ranges_.size(); i++) {
+            if (a.ranges_[i].is_zero()) continue;
+            for (size_t j = 0; j < b.ranges_.size(); j++) {
+                if (b.ranges_[j].is_zero()) continue;
+                ValueRange product = a.ranges_[i] * b.ranges_[j];
+                size_t k = i + j;
+                if (k < n) {
+                    result.ranges_[k] = result.ranges_[k] + product;
+                } else {
+                    result.ranges_[k - n] = result.ranges_[k - n] - product;
+                }
+            }
+        }
+        result.trim();
+        return result;
+    }
+
+    // True if any slot can leave [0, p), i.e. decryption would show a value mod p
+    bool wraps() const {
+        return first_wrapping_slot() < ranges_.size();
+    }
+
+    size_t first_wrapping_slot() const {
+        for (size_t i = 0; i < ranges_.size(); i++) {
+            if (!ranges_[i].fits(plain_modulus_)) return i;
+        }
+        return ranges_.size();
+    }
+
+    ValueRange slot(size_t index) const {
+        return index < ranges_.size() ? ranges_[index] : ValueRange{};
+    }
+
+    // Widest bound over all slots
+    ValueRange envelope() const {
+        if (ranges_.empty()) return ValueRange{};
+        ValueRange result = ranges_[0];
+        for (const auto &r : ranges_) {
+            result.lo = std::min(result.lo, r.lo);
+            result.hi = std::max(result.hi, r.hi);
+        }
+        return result;
+    }
+
+    PlainEncoding encoding() const { return encoding_; }
+    uint64_t plain_modulus() const { return plain_modulus_; }
+
+private:
+    PlaintextRange(PlainEncoding encoding, uint64_t plain_modulus, size_t slot_count)
+        : encoding_(encoding), plain_modulus_(plain_modulus), slot_count_(slot_count) {}
+
+    template <typename Op>
+    static PlaintextRange elementwise(const PlaintextRange &a, const PlaintextRange &b, Op op) {
+        PlaintextRange result(a.encoding_, a.plain_modulus_, a.slot_count_);
+        result.ranges_.resize(std::max(a.ranges_.size(), b.ranges_.size()));
+        for (size_t i = 0; i < result.ranges_.size(); i++) {
+            result.ranges_[i] = op(a.slot(i), b.slot(i));
+        }
+        result.trim();
+        return result;
+    }
+
+    // Coefficient ranges are stored up to the last possibly non-zero coefficient
+    void trim() {
+        if (encoding_ != PlainEncoding::COEFFICIENT) return;
+        while (!ranges_.empty() && ranges_.back().is_zero()) {
+            ranges_.pop_back();
+        }
+    }
+
+    PlainEncoding encoding_ = PlainEncoding::COEFFICIENT;
+    uint64_t plain_modulus_ = 0;
+    size_t slot_count_ = 0;
+    std::vector<ValueRange> ranges_;
+};
+
+// A ciphertext together with the bounds of the values it encrypts
+struct TrackedCiphertext {
+    seal::Ciphertext encrypted;
+    PlaintextRange range;
+    bool wrapped = false; // some earlier result already left [0, p)
+};
+
+// What an *_inplace call does when the predicted result would wrap modulo p
+enum class WrapAction {
+    SKIP, // leave the operand untouched; the caller decides what to do instead
+    RUN   // run the operation anyway and mark the result as wrapped
+};
+
+// Evaluator that predicts every result range before running the homomorphic operation.
+// predict_* only computes the range (no evaluation, no secret key). The *_inplace calls
+// predict first and return false if the result may wrap modulo p; with WrapAction::SKIP
+// the wrapping operation is not run at all.
+class RangeCheckedEvaluator {
+public:
+    RangeCheckedEvaluator(const seal::SEALContext &context, PlainEncoding encoding)
+        : evaluator_(context), encoding_(encoding),
+          plain_modulus_(context.first_context_data()->parms().plain_modulus().value()),
+          slot_count_(context.first_context_data()->parms().poly_modulus_degree()) {}
+
+    TrackedCiphertext track(const seal::Ciphertext &encrypted, const std::vector<uint64_t> &values) const {
+        return {encrypted, PlaintextRange::exact(encoding_, plain_modulus_, slot_count_, values), false};
+    }
+
+    TrackedCiphertext track(const seal::Ciphertext &encrypted, ValueRange bound) const {
+        return {encrypted, PlaintextRange::bounded(encoding_, plain_modulus_, slot_count_, bound), false};
+    }
+
+    PlaintextRange predict_add(const TrackedCiphertext &a, const TrackedCiphertext &b) const { return a.range + b.range; }
+
+    PlaintextRange predict_sub(const TrackedCiphertext &a, const TrackedCiphertext &b) const { return a.range - b.range; }
+
+    PlaintextRange predict_multiply(const TrackedCiphertext &a, const TrackedCiphertext &b) const {
+        return a.range * b.range;
+    }
+
+    // plain_range describes the plaintext's values (see PlaintextRange::from_coefficients)
+    PlaintextRange predict_multiply_plain(const TrackedCiphertext &a, const PlaintextRange &plain_range) const {
+        return a.range * plain_range;
+    }
+
+    bool add_inplace(TrackedCiphertext &a, const TrackedCiphertext &b, WrapAction on_wrap = WrapAction::SKIP) const {
+        return apply(a, b.wrapped, predict_add(a, b), on_wrap, [&] { evaluator_.add_inplace(a.encrypted, b.encrypted); });
+    }
+
+    bool sub_inplace(TrackedCiphertext &a, const TrackedCiphertext &b, WrapAction on_wrap = WrapAction::SKIP) const {
+        return apply(a, b.wrapped, predict_sub(a, b), on_wrap, [&] { evaluator_.sub_inplace(a.encrypted, b.encrypted); });
+    }
+
+    bool multiply_inplace(TrackedCiphertext &a, const TrackedCiphertext &b, WrapAction on_wrap = WrapAction::SKIP) const {
+        return apply(a, b.wrapped, predict_multiply(a, b), on_wrap,
+                     [&] { evaluator_.multiply_inplace(a.encrypted, b.encrypted); });
+    }
+
+    bool multiply_plain_inplace(TrackedCiphertext &a, const seal::Plaintext &plain, const PlaintextRange &plain_range,
+                                WrapAction on_wrap = WrapAction::SKIP) const {
+        return apply(a, false, predict_multiply_plain(a, plain_range), on_wrap,
+                     [&] { evaluator_.multiply_plain_inplace(a.encrypted, plain); });
+    }
+
+    // Coefficient encoding only: the range is read straight from the plaintext
+    bool multiply_plain_inplace(TrackedCiphertext &a, const seal::Plaintext &plain,
+                                WrapAction on_wrap = WrapAction::SKIP) const {
+        if (encoding_ != PlainEncoding::COEFFICIENT) {
+            throw std::invalid_argument("batch-encoded plaintexts need an explicit PlaintextRange");
+        }
+        return multiply_plain_inplace(a, plain, PlaintextRange::from_coefficients(plain, plain_modulus_, slot_count_),
+                                      on_wrap);
+    }
+
+    const seal::Evaluator &evaluator() const { return evaluator_; }
+
+private:
+    // The prediction is made before op() runs, so a SKIP never touches the ciphertext
+    template <typename Op>
+    bool apply(TrackedCiphertext &a, bool other_wrapped, PlaintextRange predicted, WrapAction on_wrap, Op op) const {
+        bool ok = !predicted.wraps() && !a.wrapped && !other_wrapped;
+        if (!ok && on_wrap == WrapAction::SKIP) {
+            return false;
+        }
+        op();
+        a.range = std::move(predicted);
+        a.wrapped = !ok;
+        return ok;
+    }
+
+    seal::Evaluator evaluator_;
+    PlainEncoding encoding_;
+    uint64_t plain_modulus_;
+    size_t slot_count_;
+};
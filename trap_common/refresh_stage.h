@@ -0,0 +1,143 @@
+#pragma once
+
+#include "trap_common/trap_common.h"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Trusted refresh stage: collects ciphertexts whose noise budget has dropped into the
+// policy's zone, then decrypts and re-encrypts them in batches (symmetric, seeded) so
+// they return to the computation with a full budget. A ciphertext whose budget is already
+// exhausted is never refreshed: re-encrypting it would launder a corrupted value.
+
+enum class RefreshPolicy { NEVER, AT_WARNING, AT_DANGER };
+
+// What the stage did with a submitted ciphertext
+enum class RefreshOutcome { KEPT, QUEUED, CORRUPTED };
+
+inline const char *policy_name(RefreshPolicy policy) {
+    switch (policy) {
+    case RefreshPolicy::NEVER: return "never";
+    case RefreshPolicy::AT_WARNING: return "at WARNING";
+    default: return "at DANGER";
+    }
+}
+
+struct RefreshCost {
+    uint64_t inspections = 0;
+    uint64_t refreshes = 0;
+    uint64_t corrupted = 0; // refused: noise budget already 0
+    uint64_t batches = 0;
+    double inspect_ms = 0.0;
+    double decrypt_ms = 0.0;
+    double encrypt_ms = 0.0;
+    uint64_t seeded_bytes = 0;   // what goes back to the computation side
+    uint64_t expanded_bytes = 0; // the same ciphertexts without the seed trick
+
+    double total_ms() const { return inspect_ms + decrypt_ms + encrypt_ms; }
+};
+
+class RefreshStage {
+public:
+    RefreshStage(const seal::SEALContext &context, const seal::SecretKey &secret_key, RefreshPolicy policy,
+                 int baseline_budget, int danger_threshold, size_t batch_size = 16)
+        : context_(context), decryptor_(context, secret_key), encryptor_(context, secret_key), policy_(policy),
+          baseline_budget_(baseline_budget), danger_threshold_(danger_threshold), batch_size_(batch_size),
+          pool_(seal::MemoryPoolHandle::New()), decrypted_(pool_) {}
+
+    // Measures the noise budget and decides what the policy wants done with this ciphertext.
+    // A budget of 0 means decryption may already be wrong, so it is reported as CORRUPTED.
+    RefreshOutcome inspect(const seal::Ciphertext &encrypted) {
+        auto start = std::chrono::steady_clock::now();
+        int noise_budget = decryptor_.invariant_noise_budget(encrypted);
+        cost_.inspect_ms += elapsed_ms(start);
+        cost_.inspections++;
+
+        if (noise_budget <= 0) {
+            return RefreshOutcome::CORRUPTED;
+        }
+        bool refresh;
+        switch (policy_) {
+        case RefreshPolicy::NEVER:
+            refresh = false;
+            break;
+        case RefreshPolicy::AT_WARNING:
+            refresh = noise_budget < danger_threshold_ ||
+                      classify_zone(noise_budget, baseline_budget_) != TrapZone::SAFE;
+            break;
+        default:
+            refresh = noise_budget < danger_threshold_;
+            break;
+        }
+        return refresh ? RefreshOutcome::QUEUED : RefreshOutcome::KEPT;
+    }
+
+    // Queues the ciphertext if the policy flags it; a full batch is refreshed immediately.
+    // Queued ciphertexts must not be used until flush() has run. CORRUPTED ciphertexts are
+    // left untouched and counted in cost().corrupted.
+    RefreshOutcome submit(seal::Ciphertext &encrypted) {
+        RefreshOutcome outcome = inspect(encrypted);
+        if (outcome == RefreshOutcome::CORRUPTED) {
+            cost_.corrupted++;
+        } else if (outcome == RefreshOutcome::QUEUED) {
+            pending_.push_back(&encrypted);
+            if (pending_.size() >= batch_size_) {
+                flush();
+            }
+        }
+        return outcome;
+    }
+
+    // Refreshes every queued ciphertext in place; returns how many were refreshed
+    size_t flush() {
+        if (pending_.empty()) {
+            return 0;
+        }
+        for (auto *encrypted : pending_) {
+            auto start = std::chrono::steady_clock::now();
+            decryptor_.decrypt(*encrypted, decrypted_);
+            cost_.decrypt_ms += elapsed_ms(start);
+
+            // Seeded symmetric encryption: the second polynomial is replaced by its PRNG seed,
+            // roughly halving what is sent back before it is expanded on load
+            start = std::chrono::steady_clock::now();
+            seal::Serializable<seal::Ciphertext> fresh = encryptor_.encrypt_symmetric(decrypted_, pool_);
+            buffer_.resize(static_cast<size_t>(fresh.save_size(seal::compr_mode_type::none)));
+            size_t seeded_size = static_cast<size_t>(fresh.save(buffer_.data(), buffer_.size(), seal::compr_mode_type::none));
+            encrypted->load(context_, buffer_.data(), seeded_size);
+            cost_.encrypt_ms += elapsed_ms(start);
+
+            cost_.seeded_bytes += seeded_size;
+            cost_.expanded_bytes += static_cast<uint64_t>(encrypted->save_size(seal::compr_mode_type::none));
+        }
+        size_t refreshed = pending_.size();
+        cost_.refreshes += refreshed;
+        cost_.batches++;
+        pending_.clear();
+        return refreshed;
+    }
+
+    size_t pending() const { return pending_.size(); }
+
+    const RefreshCost &cost() const { return cost_; }
+
+    RefreshPolicy policy() const { return policy_; }
+
+private:
+    static double elapsed_ms(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    seal::SEALContext context_;
+    seal::Decryptor decryptor_;
+    seal::Encryptor encryptor_;
+    RefreshPolicy policy_;
+    int baseline_budget_;
+    int danger_threshold_;
+    size_t batch_size_;
+    seal::MemoryPoolHandle pool_;
+    seal::Plaintext decrypted_;
+    std::vector<seal::seal_byte> buffer_;
+    std::vector<seal::Ciphertext *> pending_;
+    RefreshCost cost_;
+};
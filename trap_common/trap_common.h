@@ -0,0 +1,203 @@
+#pragma once
+
+#include "seal/seal.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+// Shared helpers for the long-running overflow trap tools (daemon, load client,
+// refresh stage, corpus scanner). The standalone demos keep their own copies.
+
+enum class TrapZone : uint32_t { SAFE = 0, WARNING = 1, DANGER = 2 };
+
+enum class TrapStatus : uint32_t { OK = 0, DANGER = 1, CORRUPTED = 2, ERROR = 3 };
+
+inline const char *zone_name(TrapZone zone) {
+    switch (zone) {
+    case TrapZone::SAFE: return "SAFE";
+    case TrapZone::WARNING: return "WARNING";
+    default: return "DANGER";
+    }
+}
+
+inline const char *status_name(TrapStatus status) {
+    switch (status) {
+    case TrapStatus::OK: return "OK";
+    case TrapStatus::DANGER: return "DANGER";
+    case TrapStatus::CORRUPTED: return "CORRUPTED";
+    default: return "ERROR";
+    }
+}
+
+// Same zones as the demos: SAFE >66%, WARNING 33-66%, DANGER <33% of the baseline budget
+inline TrapZone classify_zone(int noise_budget, int baseline_budget) {
+    double noise_percentage = (baseline_budget > 0) ? (noise_budget * 100.0) / baseline_budget : 0.0;
+    return (noise_percentage < 33) ? TrapZone::DANGER :
+           (noise_percentage < 66) ? TrapZone::WARNING : TrapZone::SAFE;
+}
+
+// Same tight threshold as the demos: 33% of the reference noise budget
+inline int danger_threshold(int reference_budget) {
+    return static_cast<int>(reference_budget * 0.33);
+}
+
+inline void print_trap_parameters(const seal::SEALContext &context) {
+    auto &context_data = *context.key_context_data();
+    std::cout << "\nEncryption parameters:" << std::endl;
+    std::cout << "- Scheme: BFV" << std::endl;
+    std::cout << "- Polynomial modulus degree: " << context_data.parms().poly_modulus_degree() << std::endl;
+    std::cout << "- Plain modulus (p): " << context_data.parms().plain_modulus().value() << std::endl;
+    std::cout << "- Coefficient modulus size: " << context_data.total_coeff_modulus_bit_count() << " bits" << std::endl;
+}
+
+// Parameters used by overflow_trap_demo
+inline seal::EncryptionParameters trap_default_parameters() {
+    seal::EncryptionParameters parms(seal::scheme_type::bfv);
+    parms.set_poly_modulus_degree(8192);
+    parms.set_coeff_modulus(seal::CoeffModulus::BFVDefault(8192));
+    parms.set_plain_modulus(seal::PlainModulus::Batching(8192, 20));
+    return parms;
+}
+
+// Key directory layout: parms.bin, secret_key.bin (trusted side only), public_key.bin
+inline std::string trap_key_path(const std::string &key_dir, const std::string &name) {
+    return (std::filesystem::path(key_dir) / name).string();
+}
+
+inline seal::EncryptionParameters load_trap_parameters(const std::string &key_dir) {
+    std::ifstream in(trap_key_path(key_dir, "parms.bin"), std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("cannot open " + trap_key_path(key_dir, "parms.bin"));
+    }
+    seal::EncryptionParameters parms;
+    parms.load(in);
+    return parms;
+}
+
+inline seal::PublicKey load_trap_public_key(const seal::SEALContext &context, const std::string &key_dir) {
+    std::ifstream in(trap_key_path(key_dir, "public_key.bin"), std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("cannot open " + trap_key_path(key_dir, "public_key.bin"));
+    }
+    seal::PublicKey public_key;
+    public_key.load(context, in);
+    return public_key;
+}
+
+inline seal::SecretKey load_trap_secret_key(const seal::SEALContext &context, const std::string &key_dir) {
+    std::ifstream in(trap_key_path(key_dir, "secret_key.bin"), std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("cannot open " + trap_key_path(key_dir, "secret_key.bin"));
+    }
+    seal::SecretKey secret_key;
+    secret_key.load(context, in);
+    return secret_key;
+}
+
+// Creates key_dir if needed and restricts it to the owner (0700). An existing directory
+// (e.g. --keys . or $HOME) keeps its mode.
+inline void create_trap_key_dir(const std::string &key_dir) {
+    if (std::filesystem::create_directories(key_dir)) {
+        std::filesystem::permissions(key_dir, std::filesystem::perms::owner_all,
+                                     std::filesystem::perm_options::replace);
+    }
+}
+
+// Writes the secret key to a new 0600 file; never overwrites an existing one
+inline void save_trap_secret_key(const seal::SecretKey &secret_key, const std::string &path) {
+    std::stringstream buffer;
+    secret_key.save(buffer);
+    std::string bytes = buffer.str();
+
+    int fd = ::open(path.c_str(), O_CREAT | O_EXCL | O_WRONLY, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("cannot create " + path + ": " + std::strerror(errno));
+    }
+    size_t written = 0;
+    while (written < bytes.size()) {
+        ssize_t n = ::write(fd, bytes.data() + written, bytes.size() - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            ::close(fd);
+            throw std::runtime_error("cannot write " + path + ": " + std::strerror(errno));
+        }
+        written += static_cast<size_t>(n);
+    }
+    if (::close(fd) != 0) {
+        throw std::runtime_error("cannot write " + path + ": " + std::strerror(errno));
+    }
+}
+
+// Loads parms.bin if present, otherwise writes the default parameters to key_dir
+inline seal::EncryptionParameters load_or_create_trap_parameters(const std::string &key_dir) {
+    if (std::filesystem::exists(trap_key_path(key_dir, "parms.bin"))) {
+        return load_trap_parameters(key_dir);
+    }
+    create_trap_key_dir(key_dir);
+    seal::EncryptionParameters parms = trap_default_parameters();
+    std::ofstream out(trap_key_path(key_dir, "parms.bin"), std::ios::binary);
+    parms.save(out);
+    return parms;
+}
+
+// Loads secret_key.bin if present, otherwise generates a new key pair. public_key.bin is
+// rewritten whenever a new secret key is generated (a stale one would make every request
+// decrypt as CORRUPTED) and created if it is missing, so clients encrypt against this key.
+inline seal::SecretKey load_or_create_trap_secret_key(const seal::SEALContext &context, const std::string &key_dir) {
+    seal::SecretKey secret_key;
+    std::string secret_path = trap_key_path(key_dir, "secret_key.bin");
+    bool generated = !std::filesystem::exists(secret_path);
+    if (!generated) {
+        std::ifstream in(secret_path, std::ios::binary);
+        secret_key.load(context, in);
+    } else {
+        create_trap_key_dir(key_dir);
+        seal::KeyGenerator keygen(context);
+        secret_key = keygen.secret_key();
+        save_trap_secret_key(secret_key, secret_path);
+    }
+
+    if (generated || !std::filesystem::exists(trap_key_path(key_dir, "public_key.bin"))) {
+        seal::KeyGenerator keygen(context, secret_key);
+        seal::PublicKey public_key;
+        keygen.create_public_key(public_key);
+        std::ofstream out(trap_key_path(key_dir, "public_key.bin"), std::ios::binary);
+        public_key.save(out);
+    }
+    return secret_key;
+}
+
+struct TrapVerdict {
+    TrapStatus status = TrapStatus::ERROR;
+    TrapZone zone = TrapZone::DANGER;
+    int noise_budget = 0;
+    uint64_t value = 0; // decrypted coefficient 0
+};
+
+// Trap check for one ciphertext: CORRUPTED if the value differs from the expected one,
+// DANGER if the budget is below threshold, otherwise OK. decrypted is caller-owned scratch.
+inline TrapVerdict verify_ciphertext(seal::Decryptor &decryptor, const seal::Ciphertext &encrypted,
+                                     seal::Plaintext &decrypted, bool has_expected, uint64_t expected,
+                                     int baseline_budget, int threshold) {
+    TrapVerdict verdict;
+    verdict.noise_budget = decryptor.invariant_noise_budget(encrypted);
+    decryptor.decrypt(encrypted, decrypted);
+    verdict.value = decrypted.coeff_count() > 0 ? decrypted[0] : 0;
+    verdict.zone = classify_zone(verdict.noise_budget, baseline_budget);
+    if (has_expected && verdict.value != expected) {
+        verdict.status = TrapStatus::CORRUPTED;
+    } else if (verdict.noise_budget < threshold) {
+        verdict.status = TrapStatus::DANGER;
+    } else {
+        verdict.status = TrapStatus::OK;
+    }
+    return verdict;
+}